@@ -10,9 +10,193 @@
 #include <random>
 #include <thread>
 
+// Hot-path instrumentation. Build with -DENABLE_PROFILING to record, for each
+// thread, the time spent in PROF_SCOPE blocks and a few event counters, and
+// to export them as a Chrome trace-event file (open it in chrome://tracing or
+// https://ui.perfetto.dev). Without that flag every PROF_ macro expands to
+// nothing and the instrumentation is compiled out completely.
+#ifdef ENABLE_PROFILING
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+namespace prof
+{
+
+constexpr static int MAX_THREADS = 64;
+constexpr static int MAX_EVENTS = 4096;
+constexpr static const char* TRACE_FILE = "14-threads.trace.json";
+
+enum Counter
+{
+    CANDIDATES,
+    PRIMES,
+    RETRIES,
+    N_COUNTERS
+};
+
+constexpr static const char* COUNTER_NAMES[N_COUNTERS] = {"candidates", "primes", "retries"};
+
+struct Event
+{
+    const char* name;
+    long long begin_ns;
+    long long dur_ns;
+};
+
+// Everything a thread records. Each log is written by its owning thread only,
+// with plain stores, and becomes readable by others once published.
+struct ThreadLog
+{
+    std::string name;
+    unsigned long long counters[N_COUNTERS];
+    Event events[MAX_EVENTS];
+    int n_events;
+    int dropped;
+    std::atomic<bool> published;
+};
+
+static ThreadLog g_logs[MAX_THREADS];
+static std::atomic<int> g_n_logs {0};
+static const std::chrono::steady_clock::time_point g_epoch = std::chrono::steady_clock::now();
+
+inline long long Now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - g_epoch).count();
+}
+
+// Claim a log slot for the calling thread on its first use: a single atomic
+// increment, so no thread ever waits for another one.
+// Returns nullptr once all slots are taken: that thread goes unrecorded.
+inline ThreadLog* Local()
+{
+    thread_local ThreadLog* log = [] () -> ThreadLog* {
+        const int idx = g_n_logs.fetch_add(1);
+        if (idx >= MAX_THREADS)
+            return nullptr;
+
+        std::ostringstream oss;
+        oss << "TID " << std::this_thread::get_id();
+        g_logs[idx].name = oss.str();
+        return &g_logs[idx];
+    }();
+
+    return log;
+}
+
+inline void Count(Counter c, unsigned long long n = 1)
+{
+    if (ThreadLog* log = Local())
+        log->counters[c] += n;
+}
+
+// Make the calling thread's log visible to ExportChromeTrace(). Call it once
+// the thread has nothing left to record.
+inline void Publish()
+{
+    if (ThreadLog* log = Local())
+        log->published.store(true, std::memory_order_release);
+}
+
+// Times the enclosing scope and records it as one event on destruction.
+class Scope
+{
+public:
+    explicit Scope(const char* name) :
+        m_name {name},
+        m_begin {Now()}
+    { }
+
+    ~Scope()
+    {
+        ThreadLog* log = Local();
+        if (!log)
+            return;
+
+        if (log->n_events == MAX_EVENTS)
+        {
+            ++log->dropped;
+            return;
+        }
+
+        log->events[log->n_events++] = {m_name, m_begin, Now() - m_begin};
+    }
+
+private:
+    const char* m_name;
+    long long m_begin;
+};
+
+// Write every published log to path in Chrome trace-event JSON. Threads still
+// running have not published yet and are left out.
+inline void ExportChromeTrace(const char* path)
+{
+    std::ofstream out {path};
+    // Timestamps are in microseconds: keep nanosecond resolution and never
+    // switch to scientific notation, or short events would lose their order.
+    out << std::fixed << std::setprecision(3);
+    const char* sep = "";
+    out << "{\"traceEvents\":[";
+
+    const int n = std::min(g_n_logs.load(), MAX_THREADS);
+    for (int t = 0; t < n; ++t)
+    {
+        const ThreadLog& log = g_logs[t];
+        if (!log.published.load(std::memory_order_acquire))
+            continue;
+
+        out << sep << "\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << t
+            << ",\"args\":{\"name\":\"" << log.name << "\"}}";
+        sep = ",";
+
+        long long end_ns {};
+        for (int e = 0; e < log.n_events; ++e)
+        {
+            const Event& ev = log.events[e];
+            end_ns = std::max(end_ns, ev.begin_ns + ev.dur_ns);
+            out << ",\n{\"ph\":\"X\",\"name\":\"" << ev.name << "\",\"pid\":1,\"tid\":" << t
+                << ",\"ts\":" << ev.begin_ns / 1e3 << ",\"dur\":" << ev.dur_ns / 1e3 << "}";
+        }
+
+        // Counters are reported once, as their final values for the thread.
+        out << ",\n{\"ph\":\"C\",\"name\":\"" << log.name << " counters\",\"pid\":1,\"tid\":" << t
+            << ",\"ts\":" << end_ns / 1e3 << ",\"args\":{";
+        for (int c = 0; c < N_COUNTERS; ++c)
+            out << (c ? "," : "") << "\"" << COUNTER_NAMES[c] << "\":" << log.counters[c];
+        out << ",\"dropped_events\":" << log.dropped << "}}";
+    }
+
+    out << "\n]}\n";
+}
+
+} // namespace prof
+
+#define PROF_CONCAT_(a, b) a##b
+#define PROF_CONCAT(a, b) PROF_CONCAT_(a, b)
+#define PROF_SCOPE(name) prof::Scope PROF_CONCAT(prof_scope_, __LINE__) {name}
+#define PROF_COUNT(counter) prof::Count(prof::counter)
+#define PROF_PUBLISH() prof::Publish()
+#define PROF_EXPORT() prof::ExportChromeTrace(prof::TRACE_FILE)
+
+#else
+
+#define PROF_SCOPE(name) ((void) 0)
+#define PROF_COUNT(counter) ((void) 0)
+#define PROF_PUBLISH() ((void) 0)
+#define PROF_EXPORT() ((void) 0)
+
+#endif // ENABLE_PROFILING
+
 // Source: https://en.wikipedia.org/wiki/Primality_test#C,_C++,_C#_&_D
 bool IsPrime(int n)
 {
+    PROF_SCOPE("IsPrime");
+
     if (n == 2 || n == 3)
         return true;
 
@@ -33,17 +217,26 @@ void GenRndPrime(const long unsigned seed)
 
     try
     {
+        PROF_SCOPE("GenRndPrime");
         std::cout << "TID " << std::this_thread::get_id() << " started" << std::endl;
 
         std::default_random_engine dre {seed};
         std::uniform_int_distribution<int> uid {UID_MIN, UID_MAX};
         int n {};
+        bool found {};
 
         do 
         {
             n = uid(dre);
+            PROF_COUNT(CANDIDATES);
+
+            found = IsPrime(n);
+            if (!found)
+                PROF_COUNT(RETRIES);
         }
-        while (!IsPrime(n));
+        while (!found);
+
+        PROF_COUNT(PRIMES);
 
         std::cout << "TID " << std::this_thread::get_id() << " found prime: " << n << std::endl;
     }
@@ -59,6 +252,8 @@ void GenRndPrime(const long unsigned seed)
     {
         std::cerr << "ERROR [TID " << std::this_thread::get_id() << "] " << std::endl;
     }
+
+    PROF_PUBLISH();
 }
 
 int main()
@@ -77,6 +272,9 @@ int main()
         std::cout << "Waiting for TID " << t1.get_id() << std::endl;
         t1.join();
 
+        // t2 was detached: its timeline is only exported if it is done by now.
+        PROF_EXPORT();
+
         std::cout << "Finished!" << std::endl;
     }
     catch (const std::exception& e)
@@ -11,29 +11,105 @@
 //    -            "int 40 2" => "42"
 //    -      "float 3.0 0.14" => "3.14"
 //
+// The program can also keep running as a server, reading one request per line
+// from standard input and writing one answer per line to standard output:
+//      --serve [workers]
+// or measure the latency and throughput of such a server, run as a child
+// process and driven through pipes on its standard input and output:
+//      --loadgen <requests> <clients> [in_flight_per_client] [workers]
+// or concatenate many string pairs in batches through a StringArena:
+//      --concat <pairs> <batch_size>
+//
 
+#include <cerrno>        // Provides errno to detect out of range conversions.
+#include <climits>       // Provides INT_MIN and INT_MAX.
+#include <csignal>       // Provides std::signal to ignore SIGPIPE.
+#include <cstdio>        // Provides std::snprintf to format numbers.
 #include <cstdlib>       // Provides std::exit to terminate the program gracefully.
+#include <cstring>       // Provides std::memcpy to copy raw bytes.
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <exception>
 #include <functional>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
 #include <sstream>
+#include <stdexcept>
 #include <string>
+#include <system_error>
+#include <thread>
 #include <unordered_map> // associative array with unique keys.
 #include <vector>
 
+#include <sys/types.h>   // POSIX: pid_t and ssize_t.
+#include <sys/wait.h>    // POSIX: waitpid to reap the server process.
+#include <unistd.h>      // POSIX: pipe, fork, dup2, read and write.
+
 // Macro helper to create a lambda function from a given data type and
-// conversion function.
-#define MakeLambda(TYPE, CONVF)                                 \
-    [] (const std::string& op1str, const std::string& op2str) { \
-        const TYPE op1 {CONVF(op1str)};                         \
-        const TYPE op2 {CONVF(op2str)};                         \
-        const SumObj<TYPE> so {op1, op2};                       \
-        std::cout << so.Eval() << std::endl;                    \
+// conversion function. The conversion function returns false for an invalid
+// operand, instead of throwing.
+#define MakeLambda(TYPE, CONVF)                                                         \
+    [] (const std::string& op1str, const std::string& op2str, std::string& out) {       \
+        TYPE op1 {};                                                                    \
+        TYPE op2 {};                                                                    \
+        if (!CONVF(op1str, op1) || !CONVF(op2str, op2))                                 \
+        {                                                                               \
+            out = "invalid " #TYPE " operands: " + op1str + " " + op2str;               \
+            return false;                                                               \
+        }                                                                               \
+        const SumObj<TYPE> so {op1, op2};                                               \
+        Format(so.Eval(), out);                                                         \
+        return true;                                                                    \
     }
 
-// Macro helper to create a lambda function from a given data type only.
-#define MakeLambdaNoConv(TYPE) MakeLambda(TYPE, )
+// Convert the whole of s to an int. Fails on empty input, trailing characters
+// and values out of range.
+bool ToInt(const std::string& s, int& v)
+{
+    char* end;
+    errno = 0;
+    const long l = std::strtol(s.c_str(), &end, 10);
+
+    if (end == s.c_str() || *end != '\0' || errno == ERANGE || l < INT_MIN || l > INT_MAX)
+        return false;
+
+    v = static_cast<int>(l);
+    return true;
+}
+
+// Convert the whole of s to a float, with the same rules as ToInt.
+bool ToFloat(const std::string& s, float& v)
+{
+    char* end;
+    errno = 0;
+    const float f = std::strtof(s.c_str(), &end);
+
+    if (end == s.c_str() || *end != '\0' || errno == ERANGE)
+        return false;
+
+    v = f;
+    return true;
+}
+
+// Write a number to out as std::cout would, without a stream.
+void Format(int v, std::string& out)
+{
+    char buf[16];
+    out.assign(buf, std::snprintf(buf, sizeof(buf), "%d", v));
+}
+
+void Format(float v, std::string& out)
+{
+    char buf[32];
+    out.assign(buf, std::snprintf(buf, sizeof(buf), "%g", v));
+}
 
 // Generic data class to store and evaluate the sum of two operands
 template<typename T>
@@ -55,12 +131,781 @@ private:
     const T m_op2;
 };
 
-// Eval specialization for string, as strings should present a space during
-// concatenation.
+// Default size of the memory blocks handed out by a StringArena.
+constexpr static size_t ARENA_BLOCK_SIZE = 64 * 1024;
+
+// Non-owning reference to a sequence of characters stored elsewhere, e.g. in
+// a std::string or in a StringArena. It must not outlive its storage.
+class StrRef
+{
+public:
+    StrRef(const char* data, size_t size) :
+        m_data {data},
+        m_size {size}
+    { }
+
+    explicit StrRef(const std::string& s) :
+        StrRef {s.data(), s.size()}
+    { }
+
+    // A temporary string would be destroyed while still referenced.
+    StrRef(std::string&&) = delete;
+
+    const char* Data() const
+    {
+        return m_data;
+    }
+
+    size_t Size() const
+    {
+        return m_size;
+    }
+
+    std::string Str() const
+    {
+        return {m_data, m_size};
+    }
+
+private:
+    const char* m_data;
+    size_t m_size;
+};
+
+std::ostream& operator<<(std::ostream& os, const StrRef& s)
+{
+    return os.write(s.Data(), s.Size());
+}
+
+// Bump allocator for strings: memory is carved out of large blocks and only
+// released all at once, when the arena is destroyed or reset.
+class StringArena
+{
+public:
+    // Make sure the next n bytes can be allocated without a new block.
+    void Reserve(size_t n)
+    {
+        if (m_left < n)
+        {
+            const size_t size = std::max(n, ARENA_BLOCK_SIZE);
+            m_blocks.emplace_back(new char[size]);
+            ++m_allocations;
+            m_next = m_blocks.back().get();
+            m_left = size;
+            m_lastSize = size;
+        }
+    }
+
+    char* Allocate(size_t n)
+    {
+        Reserve(n);
+        char* p = m_next;
+        m_next += n;
+        m_left -= n;
+        return p;
+    }
+
+    // Invalidate everything allocated so far. The most recent block is kept
+    // for reuse, so batches of similar size stop allocating at all.
+    void Reset()
+    {
+        if (m_blocks.empty())
+            return;
+
+        std::unique_ptr<char[]> last {std::move(m_blocks.back())};
+        m_blocks.clear();
+        m_blocks.push_back(std::move(last));
+        m_next = m_blocks.back().get();
+        m_left = m_lastSize;
+    }
+
+    // Blocks currently held.
+    size_t Blocks() const
+    {
+        return m_blocks.size();
+    }
+
+    // Blocks allocated since construction.
+    size_t Allocations() const
+    {
+        return m_allocations;
+    }
+
+private:
+    std::vector<std::unique_ptr<char[]>> m_blocks;
+    size_t m_allocations {};
+    char* m_next {};
+    size_t m_left {};
+    size_t m_lastSize {};
+};
+
+// Specialization for strings, which are concatenated with a space in between.
+// It works as a string builder: operands are referenced, not copied, and the
+// result is written in a single pass, either to a string or to arena memory.
 template<>
-std::string SumObj<std::string>::Eval() const
+class SumObj<StrRef>
+{
+public:
+    SumObj(const StrRef& op1, const StrRef& op2) :
+        m_op1 {op1},
+        m_op2 {op2}
+    { }
+
+    // Length of the concatenation, known before building it.
+    size_t Size() const
+    {
+        return m_op1.Size() + 1 + m_op2.Size();
+    }
+
+    // Write the concatenation to out, growing it at most once.
+    void Eval(std::string& out) const
+    {
+        out.clear();
+        out.reserve(Size());
+        out.append(m_op1.Data(), m_op1.Size()).append(1, ' ').append(m_op2.Data(), m_op2.Size());
+    }
+
+    // Write the concatenation to arena memory and reference it.
+    StrRef Eval(StringArena& arena) const
+    {
+        char* p = arena.Allocate(Size());
+        std::memcpy(p, m_op1.Data(), m_op1.Size());
+        p[m_op1.Size()] = ' ';
+        std::memcpy(p + m_op1.Size() + 1, m_op2.Data(), m_op2.Size());
+        return {p, Size()};
+    }
+
+private:
+    const StrRef m_op1;
+    const StrRef m_op2;
+};
+
+// Concatenate a whole batch of operand pairs into out. The arena is grown at
+// most once, by the total length of the batch, and out keeps its capacity
+// between batches: string data costs at most one allocation per batch.
+void ConcatBatch(const std::vector<SumObj<StrRef>>& batch, StringArena& arena, std::vector<StrRef>& out)
+{
+    size_t total {};
+    for (const auto& so : batch)
+        total += so.Size();
+
+    arena.Reserve(total);
+    out.clear();
+    for (const auto& so : batch)
+        out.push_back(so.Eval(arena));
+}
+
+// Concatenate pairs operand pairs, batchSize pairs at a time, through one
+// arena that is reset between batches, and report how many blocks it took.
+int ConcatBatches(size_t pairs, size_t batchSize)
+{
+    batchSize = std::min(batchSize, pairs);
+
+    // The operands stay the same from one batch to the next: only the
+    // concatenation is measured.
+    std::vector<std::string> ops1;
+    std::vector<std::string> ops2;
+    std::vector<SumObj<StrRef>> batch;
+    for (size_t i = 0; i < batchSize; ++i)
+    {
+        ops1.push_back("key" + std::to_string(i));
+        ops2.push_back("value" + std::to_string(i));
+    }
+    for (size_t i = 0; i < batchSize; ++i)
+        batch.emplace_back(StrRef {ops1[i]}, StrRef {ops2[i]});
+
+    const std::vector<SumObj<StrRef>> tail(batch.begin(), batch.begin() + pairs % batchSize);
+
+    StringArena arena;
+    std::vector<StrRef> out;
+    out.reserve(batchSize);
+
+    const auto start = std::chrono::steady_clock::now();
+    ConcatBatch(batch, arena, out);
+    const size_t before = arena.Blocks();
+    arena.Reset();
+    const size_t after = arena.Blocks();
+
+    for (size_t done = batchSize; done < pairs; done += batchSize)
+    {
+        arena.Reset();
+        ConcatBatch(pairs - done >= batchSize ? batch : tail, arena, out);
+    }
+    const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << "pairs: " << pairs << ", batches: " << (pairs + batchSize - 1) / batchSize
+              << ", last result: " << out.back() << std::endl;
+    std::cout << "arena blocks before Reset: " << before << ", after Reset: " << after
+              << ", allocated in total: " << arena.Allocations() << std::endl;
+    std::cout << "time per pair: " << elapsed.count() / pairs << " ns" << std::endl;
+
+    return EXIT_SUCCESS;
+}
+
+// ===========================================================================
+// Server mode
+// ===========================================================================
+
+// Maximum number of requests waiting for a worker, and of responses waiting
+// to be written, before producers block.
+constexpr static size_t QUEUE_CAPACITY = 1024;
+
+// Upper bound on the worker threads of a server.
+constexpr static int MAX_WORKERS = 256;
+
+// Upper bound on the client threads of the load generator.
+constexpr static int MAX_CLIENTS = 1024;
+
+// Output buffered by the server before it is written out.
+constexpr static size_t OUTPUT_BUFFER_SIZE = 64 * 1024;
+
+typedef std::chrono::steady_clock Clock;
+
+// Associative array that binds together a type name to its evaluation lambda.
+// The lambda writes the result, or an error message, to its last argument and
+// returns whether the operands were valid.
+typedef std::unordered_map<std::string,
+                           std::function<bool(const std::string&, const std::string&, std::string&)>>
+TypeMap;
+
+// Blocking queue with a fixed capacity, safe for any number of producers and
+// consumers. Push() waits while the queue is full, Pop() while it is empty.
+template<typename T>
+class BoundedQueue
+{
+public:
+    explicit BoundedQueue(size_t capacity) :
+        m_capacity {capacity}
+    { }
+
+    // Returns false, dropping item, if the queue has been closed.
+    bool Push(T&& item)
+    {
+        std::unique_lock<std::mutex> lock {m_mutex};
+        m_notFull.wait(lock, [this] { return m_closed || m_items.size() < m_capacity; });
+        if (m_closed)
+            return false;
+
+        m_items.push_back(std::move(item));
+        m_notEmpty.notify_one();
+        return true;
+    }
+
+    // Returns false once the queue is closed and drained.
+    bool Pop(T& item)
+    {
+        std::unique_lock<std::mutex> lock {m_mutex};
+        m_notEmpty.wait(lock, [this] { return m_closed || !m_items.empty(); });
+        if (m_items.empty())
+            return false;
+
+        item = std::move(m_items.front());
+        m_items.pop_front();
+        m_notFull.notify_one();
+        return true;
+    }
+
+    bool Empty()
+    {
+        std::lock_guard<std::mutex> lock {m_mutex};
+        return m_items.empty();
+    }
+
+    // Wake everybody up: no more items can be pushed, the remaining ones can
+    // still be popped.
+    void Close()
+    {
+        std::lock_guard<std::mutex> lock {m_mutex};
+        m_closed = true;
+        m_notFull.notify_all();
+        m_notEmpty.notify_all();
+    }
+
+private:
+    const size_t m_capacity;
+    std::deque<T> m_items;
+    std::mutex m_mutex;
+    std::condition_variable m_notFull;
+    std::condition_variable m_notEmpty;
+    bool m_closed {false};
+};
+
+// One "<data_type> <op1> <op2>" line, numbered in arrival order.
+struct Request
+{
+    size_t seq;
+    std::string line;
+};
+
+struct Response
+{
+    size_t seq;
+    std::string text;
+};
+
+// Evaluate a request line into out, which ends up holding either the result
+// or an "ERROR: ..." message.
+void Evaluate(const TypeMap& types, const std::string& line, std::string& out)
+{
+    // Split the line on blanks into at most three fields. They are kept per
+    // thread, so their buffers are reused from one request to the next.
+    thread_local std::string fields[3];
+    size_t n {};
+    size_t pos {};
+
+    while (n < 3)
+    {
+        const size_t b = line.find_first_not_of(" \t\r", pos);
+        if (b == std::string::npos)
+            break;
+        pos = line.find_first_of(" \t\r", b);
+        fields[n++].assign(line, b, pos == std::string::npos ? std::string::npos : pos - b);
+    }
+
+    if (n != 3 || line.find_first_not_of(" \t\r", pos) != std::string::npos)
+    {
+        out = "ERROR: expected <data_type> <op1> <op2>";
+        return;
+    }
+
+    const auto it = types.find(fields[0]);
+    if (it == types.end())
+    {
+        out = "ERROR: unsupported data type: " + fields[0];
+        return;
+    }
+
+    if (!it->second(fields[1], fields[2], out))
+        out.insert(0, "ERROR: ");
+}
+
+// Long-running calculator: requests submitted from any thread are evaluated by
+// a fixed pool of workers, and their responses are handed to emit strictly in
+// submission order, so clients can pipeline requests without waiting for each
+// answer. flush is called whenever no response is left to emit.
+class CalcServer
+{
+public:
+    CalcServer(const TypeMap& types, size_t workers,
+               std::function<void(const Response&)> emit, std::function<void()> flush) :
+        m_types (types),
+        m_requests {QUEUE_CAPACITY},
+        m_responses {QUEUE_CAPACITY},
+        m_emit {emit},
+        m_flush {flush},
+        m_nextSeq {}
+    {
+        // If a thread cannot be started, stop the ones already running before
+        // giving up: destroying a joinable std::thread terminates the program.
+        try
+        {
+            for (size_t i = 0; i < workers; ++i)
+                m_workers.emplace_back(&CalcServer::Work, this);
+
+            m_writer = std::thread {&CalcServer::Write, this};
+        }
+        catch (...)
+        {
+            m_requests.Close();
+            for (auto& t : m_workers)
+                t.join();
+
+            m_responses.Close();
+            throw;
+        }
+    }
+
+    ~CalcServer()
+    {
+        Close();
+    }
+
+    CalcServer(const CalcServer&) = delete;
+    CalcServer& operator=(const CalcServer&) = delete;
+
+    // Blocks while QUEUE_CAPACITY requests are already waiting. Returns false,
+    // dropping line, once the server is closed.
+    bool Submit(std::string&& line)
+    {
+        // Number the request only if it is queued: a gap in the sequence would
+        // make the writer hold back every later response.
+        std::lock_guard<std::mutex> lock {m_submitMutex};
+        if (!m_requests.Push({m_nextSeq, std::move(line)}))
+            return false;
+
+        ++m_nextSeq;
+        return true;
+    }
+
+    // Stop accepting requests, answer all the pending ones and wait for the
+    // threads to finish.
+    void Close()
+    {
+        if (!m_writer.joinable())
+            return;
+
+        m_requests.Close();
+        for (auto& t : m_workers)
+            t.join();
+
+        m_responses.Close();
+        m_writer.join();
+    }
+
+private:
+    void Work()
+    {
+        Request req;
+
+        while (m_requests.Pop(req))
+        {
+            Response res {req.seq, {}};
+
+            // make sure no exception leaves the thread, answer with it instead
+            try
+            {
+                Evaluate(m_types, req.line, res.text);
+            }
+            catch (const std::exception& e)
+            {
+                res.text = std::string {"ERROR: "} + e.what();
+            }
+
+            m_responses.Push(std::move(res));
+        }
+    }
+
+    // Responses arrive in completion order: hold back the early ones until
+    // every response before them has been emitted.
+    void Write()
+    {
+        std::map<size_t, Response> early;
+        size_t next {};
+        Response res;
+
+        while (m_responses.Pop(res))
+        {
+            early.emplace(res.seq, std::move(res));
+
+            for (auto it = early.begin(); it != early.end() && it->first == next; it = early.erase(it))
+            {
+                m_emit(it->second);
+                ++next;
+            }
+
+            if (m_responses.Empty())
+                m_flush();
+        }
+
+        m_flush();
+    }
+
+    const TypeMap& m_types;
+    BoundedQueue<Request> m_requests;
+    BoundedQueue<Response> m_responses;
+    std::function<void(const Response&)> m_emit;
+    std::function<void()> m_flush;
+    std::mutex m_submitMutex;
+    size_t m_nextSeq;
+    std::vector<std::thread> m_workers;
+    std::thread m_writer;
+};
+
+size_t WorkerCount()
 {
-    return m_op1 + " " + m_op2;
+    return std::max<size_t>(1, std::thread::hardware_concurrency());
+}
+
+// Serve one request per line of standard input, answering with one line per
+// request on standard output, in the same order.
+int Serve(const TypeMap& types, size_t workers)
+{
+    // Only the writer thread may touch std::cout: untie it from std::cin, or
+    // reading a request would flush std::cout from this thread.
+    std::ios::sync_with_stdio(false);
+    std::cin.tie(nullptr);
+
+    std::string buffer;
+    CalcServer server {
+        types, workers,
+        [&] (const Response& res) {
+            buffer.append(res.text).append(1, '\n');
+            if (buffer.size() >= OUTPUT_BUFFER_SIZE)
+            {
+                std::cout.write(buffer.data(), buffer.size());
+                buffer.clear();
+            }
+        },
+        [&] {
+            std::cout.write(buffer.data(), buffer.size()).flush();
+            buffer.clear();
+        }
+    };
+
+    std::string line;
+    while (std::getline(std::cin, line))
+        if (!server.Submit(std::move(line)))
+            break;
+
+    server.Close();
+    return EXIT_SUCCESS;
+}
+
+// Write the size bytes at data to fd, resuming after partial writes and
+// interruptions. Returns false if the descriptor fails.
+bool WriteAll(int fd, const char* data, size_t size)
+{
+    while (size > 0)
+    {
+        const ssize_t n = ::write(fd, data, size);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+            return false;
+
+        data += n;
+        size -= n;
+    }
+    return true;
+}
+
+// Load generator: run "--serve" with the given workers in a child process and
+// talk to it through pipes on its standard input and output, as any client of
+// the service would. clients threads share requests in total, and each of them
+// keeps at most inFlight requests outstanding: new ones are written only as
+// answers come back (closed loop). Latency runs from writing a request to the
+// pipe until its answer is read back, so it covers the transport and Serve's
+// buffering and flushing, not just the evaluation.
+int LoadGen(const TypeMap& types, size_t requests, size_t clients, size_t inFlight, size_t workers)
+{
+    static const char* SAMPLES[] = {"string hello world\n", "int 40 2\n", "float 3.0 0.14\n", "int 40 x\n"};
+
+    int toServer[2] {-1, -1};
+    int fromServer[2] {-1, -1};
+
+    auto closeFd = [] (int& fd) {
+        if (fd >= 0)
+            ::close(fd);
+        fd = -1;
+    };
+
+    auto fail = [&] (const char* what) {
+        const std::error_code err {errno, std::generic_category()};
+        for (int* fd : {&toServer[0], &toServer[1], &fromServer[0], &fromServer[1]})
+            closeFd(*fd);
+        throw std::system_error {err, what};
+    };
+
+    if (::pipe(toServer) != 0 || ::pipe(fromServer) != 0)
+        fail("pipe");
+
+    // Fork before starting any thread, the child only gets a copy of this one.
+    // Flush first, or the child would write our pending output once more.
+    std::cout.flush();
+    const pid_t pid = ::fork();
+    if (pid < 0)
+        fail("fork");
+
+    if (pid == 0)
+    {
+        // Child: serve on the far ends of the pipes. Every other copy of them
+        // must be closed, or the server would never see the end of its input.
+        if (::dup2(toServer[0], STDIN_FILENO) < 0 || ::dup2(fromServer[1], STDOUT_FILENO) < 0)
+            ::_exit(EXIT_FAILURE);
+        for (int* fd : {&toServer[0], &toServer[1], &fromServer[0], &fromServer[1]})
+            closeFd(*fd);
+
+        int status {EXIT_FAILURE};
+        try
+        {
+            status = Serve(types, workers);
+        }
+        catch (std::exception const& e)
+        {
+            std::cerr << "ERROR: " << e.what() << std::endl;
+        }
+        std::exit(status);
+    }
+
+    closeFd(toServer[0]);
+    closeFd(fromServer[1]);
+
+    // A server that went away must make our writes fail, not kill us.
+    std::signal(SIGPIPE, SIG_IGN);
+
+    struct Client
+    {
+        std::mutex mutex;
+        std::condition_variable answered;
+        size_t outstanding {};
+    };
+
+    // Requests written in one go by a client, in the order the server reads
+    // them: its answers come back in the same order.
+    struct Sent
+    {
+        size_t client;
+        size_t count;
+        Clock::time_point at;
+    };
+
+    std::vector<std::unique_ptr<Client>> state;
+    for (size_t c = 0; c < clients; ++c)
+        state.emplace_back(new Client);
+
+    std::mutex writeMutex;      // keeps each batch of lines in one piece
+    std::mutex sentMutex;       // guards sent
+    std::deque<Sent> sent;
+    std::atomic<bool> stopped {false};
+
+    // Only the reader thread touches these.
+    std::vector<Clock::duration> latencies;
+    latencies.reserve(requests);
+    Clock::time_point finish;
+
+    // Wake every client up and make it return.
+    auto stop = [&] {
+        stopped = true;
+        for (auto& client : state)
+        {
+            std::lock_guard<std::mutex> lock {client->mutex};
+            client->answered.notify_all();
+        }
+    };
+
+    auto send = [&] (size_t c) {
+        Client& client = *state[c];
+        std::string batch;
+
+        for (size_t i = c; i < requests;)
+        {
+            size_t count;
+            {
+                std::unique_lock<std::mutex> lock {client.mutex};
+                client.answered.wait(lock, [&] { return stopped || client.outstanding < inFlight; });
+                if (stopped)
+                    return;
+
+                count = std::min(inFlight - client.outstanding, (requests - i + clients - 1) / clients);
+                client.outstanding += count;
+            }
+
+            batch.clear();
+            for (size_t k = 0; k < count; ++k, i += clients)
+                batch += SAMPLES[i % 4];
+
+            std::lock_guard<std::mutex> lock {writeMutex};
+            {
+                std::lock_guard<std::mutex> sentLock {sentMutex};
+                sent.push_back({c, count, Clock::now()});
+            }
+
+            if (!WriteAll(toServer[1], batch.data(), batch.size()))
+            {
+                stop();
+                return;
+            }
+        }
+    };
+
+    // Match every answer line to the oldest request still waiting for one,
+    // until the server closes its output.
+    auto receive = [&] {
+        char buffer[OUTPUT_BUFFER_SIZE];
+
+        for (;;)
+        {
+            const ssize_t n = ::read(fromServer[0], buffer, sizeof buffer);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                break;
+
+            finish = Clock::now();
+            for (const char* p = buffer; (p = static_cast<const char*>(std::memchr(p, '\n', buffer + n - p))); ++p)
+            {
+                size_t c;
+                {
+                    std::lock_guard<std::mutex> lock {sentMutex};
+                    if (sent.empty())
+                        continue;
+
+                    Sent& s = sent.front();
+                    latencies.push_back(finish - s.at);
+                    c = s.client;
+                    if (--s.count == 0)
+                        sent.pop_front();
+                }
+
+                Client& client = *state[c];
+                {
+                    std::lock_guard<std::mutex> lock {client.mutex};
+                    --client.outstanding;
+                }
+                client.answered.notify_one();
+            }
+        }
+    };
+
+    std::thread reader;
+    std::vector<std::thread> threads;
+    int status {};
+
+    // Closing the requests pipe lets the server answer what it has and exit,
+    // which ends the reader. Without a reader, closing the answers pipe makes
+    // the server fail rather than block on a full pipe.
+    auto shutdown = [&] {
+        closeFd(toServer[1]);
+        if (reader.joinable())
+            reader.join();
+        closeFd(fromServer[0]);
+
+        while (::waitpid(pid, &status, 0) < 0 && errno == EINTR)
+            ;
+    };
+
+    const auto start = Clock::now();
+
+    // If a thread cannot be started, stop the ones already running before
+    // giving up: destroying a joinable std::thread terminates the program.
+    try
+    {
+        reader = std::thread {receive};
+        threads.reserve(clients);
+        for (size_t c = 0; c < clients; ++c)
+            threads.emplace_back(send, c);
+    }
+    catch (...)
+    {
+        stop();
+        for (auto& t : threads)
+            t.join();
+
+        shutdown();
+        throw;
+    }
+
+    for (auto& t : threads)
+        t.join();
+
+    shutdown();
+
+    if (stopped || latencies.size() != requests || !WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS)
+        throw std::runtime_error {"the server process failed"};
+
+    const std::chrono::duration<double> elapsed = finish - start;
+
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&] (double p) {
+        const size_t idx = std::min(latencies.size() - 1, static_cast<size_t>(p * latencies.size()));
+        return std::chrono::duration_cast<std::chrono::microseconds>(latencies[idx]).count();
+    };
+
+    std::cout << "requests: " << latencies.size() << ", clients: " << clients
+              << ", in flight per client: " << inFlight << ", workers: " << workers << std::endl;
+    std::cout << "p50: " << percentile(0.50) << " us, p99: " << percentile(0.99) << " us" << std::endl;
+    std::cout << "throughput: " << static_cast<size_t>(latencies.size() / elapsed.count()) << " ops/s" << std::endl;
+
+    return EXIT_SUCCESS;
 }
 
 int main(const int argc, const char** argv)
@@ -71,12 +916,16 @@ int main(const int argc, const char** argv)
     constexpr static int OP1_IDX = 1;
     constexpr static int OP2_IDX = 2;
 
-    // Associative array that binds together a type name to its conversion lambda
-    std::unordered_map<std::string, std::function<void(const std::string&, const std::string&)>>
-    supportedTypes {
-        {"string", MakeLambdaNoConv(std::string)},
-        {"int", MakeLambda(int, std::stoi)},
-        {"float", MakeLambda(float, std::stof)}
+    // Associative array that binds together a type name to its evaluation lambda
+    TypeMap supportedTypes {
+        {"string", [] (const std::string& op1str, const std::string& op2str, std::string& out) {
+            // A single answer needs no arena: build it straight into out.
+            const SumObj<StrRef> so {StrRef {op1str}, StrRef {op2str}};
+            so.Eval(out);
+            return true;
+        }},
+        {"int", MakeLambda(int, ToInt)},
+        {"float", MakeLambda(float, ToFloat)}
     };
 
     // Inline utility to check if a condition is true, otherwise close the program
@@ -101,9 +950,60 @@ int main(const int argc, const char** argv)
         return oss.str();
     };
 
-    check(argc == ARGS_N, "Please insert three arguments in this format: <data_type> <op1> <op2>");
+    // Inline utility to run one of the long-running modes, reporting a failure
+    // the same way a single calculation does.
+    auto run = [] (const std::function<int()>& mode) -> int
+    {
+        try
+        {
+            return mode();
+        }
+        catch (std::exception const& e)
+        {
+            std::cout << "ERROR: " << e.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+    };
 
     const std::vector<std::string> args {argv + 1, argv + argc};
+
+    if (!args.empty() && args[DT_IDX] == "--serve")
+    {
+        int workers {static_cast<int>(WorkerCount())};
+        check(args.size() == 1 || (args.size() == 2 && ToInt(args[1], workers)),
+              "Usage: --serve [workers]");
+        check(workers > 0 && workers <= MAX_WORKERS, "workers must be between 1 and " + std::to_string(MAX_WORKERS));
+        return run([&] { return Serve(supportedTypes, workers); });
+    }
+
+    if (!args.empty() && args[DT_IDX] == "--loadgen")
+    {
+        int requests {};
+        int clients {};
+        int inFlight {1};
+        int workers {static_cast<int>(WorkerCount())};
+        check(args.size() >= 3 && args.size() <= 5 && ToInt(args[1], requests) && ToInt(args[2], clients) &&
+              (args.size() < 4 || ToInt(args[3], inFlight)) && (args.size() < 5 || ToInt(args[4], workers)) &&
+              requests > 0 && clients > 0 && inFlight > 0,
+              "Usage: --loadgen <requests> <clients> [in_flight_per_client] [workers]\n"
+              "Runs --serve [workers] as a child process and reports the latency, through its\n"
+              "standard input and output, and the throughput seen by the clients.");
+        check(clients <= MAX_CLIENTS, "clients must be between 1 and " + std::to_string(MAX_CLIENTS));
+        check(workers > 0 && workers <= MAX_WORKERS, "workers must be between 1 and " + std::to_string(MAX_WORKERS));
+        return run([&] { return LoadGen(supportedTypes, requests, clients, inFlight, workers); });
+    }
+
+    if (!args.empty() && args[DT_IDX] == "--concat")
+    {
+        int pairs {};
+        int batchSize {};
+        check(args.size() == 3 && ToInt(args[1], pairs) && ToInt(args[2], batchSize) && pairs > 0 && batchSize > 0,
+              "Usage: --concat <pairs> <batch_size>");
+        return run([&] { return ConcatBatches(pairs, batchSize); });
+    }
+
+    check(argc == ARGS_N, "Please insert three arguments in this format: <data_type> <op1> <op2>");
+
     const auto& dt = args[DT_IDX];
 
     check(supportedTypes.count(dt) == 1, "Unsupported data type: " + dt + ". Supported data types are " + supportedTypeKeys());
@@ -112,7 +1012,15 @@ int main(const int argc, const char** argv)
     {
         const auto& op1 = args[OP1_IDX];
         const auto& op2 = args[OP2_IDX];
-        supportedTypes[dt](op1, op2);
+        std::string result;
+
+        if (!supportedTypes[dt](op1, op2, result))
+        {
+            std::cout << "ERROR: " << result << std::endl;
+            std::exit(EXIT_FAILURE);
+        }
+
+        std::cout << result << std::endl;
     }
     catch (std::exception const& e)
     {
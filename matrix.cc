@@ -1,22 +1,431 @@
+#include <cmath>
+#include <cstddef>
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <numeric>
+#include <type_traits>
 #include <stdexcept>
 #include <iostream>
+#include <thread>
+#include <utility>
 #include <vector>
 
+// Below this many elements per side, the recursive transpose stops splitting
+// and swaps elements directly. Any small value works: the recursion adapts to
+// every level of the cache hierarchy without knowing its sizes.
+constexpr static size_t TRANSPOSE_LEAF = 16;
+
+// Non-owning, strided window over elements stored elsewhere. Element (i, j)
+// lives at m_data[i * m_rowStride + j * m_colStride], so rows, columns,
+// blocks and transposes of a Matrix are all just different strides over the
+// very same storage: nothing is copied.
+// Use MatrixView<const T> for read-only access.
+template<typename T>
+class MatrixView
+{
+public:
+    // Row-major forward iterator over the elements of the view, usable with
+    // range-based for loops and standard algorithms.
+    class iterator
+    {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef typename std::remove_const<T>::type value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef T* pointer;
+        typedef T& reference;
+
+        // The position is kept as a (row, column) index pair rather than a
+        // pointer: past the last row, a pointer into a strided view may lie
+        // beyond the end of the underlying storage.
+        iterator(T* data, size_t i, size_t cols, size_t rowStride, size_t colStride) :
+            m_data {data},
+            m_i {i},
+            m_j {},
+            m_cols {cols},
+            m_rowStride {rowStride},
+            m_colStride {colStride}
+        { }
+
+        T& operator*() const
+        {
+            return m_data[m_i * m_rowStride + m_j * m_colStride];
+        }
+
+        T* operator->() const
+        {
+            return &**this;
+        }
+
+        iterator& operator++()
+        {
+            if (++m_j == m_cols)
+            {
+                m_j = 0;
+                ++m_i;
+            }
+            return *this;
+        }
+
+        iterator operator++(int)
+        {
+            iterator old {*this};
+            ++*this;
+            return old;
+        }
+
+        bool operator==(const iterator& other) const
+        {
+            return m_i == other.m_i && m_j == other.m_j;
+        }
+
+        bool operator!=(const iterator& other) const
+        {
+            return !(*this == other);
+        }
+
+    private:
+        T* m_data;
+        size_t m_i;
+        size_t m_j;
+        size_t m_cols;
+        size_t m_rowStride;
+        size_t m_colStride;
+    };
+
+    MatrixView(T* data, size_t rows, size_t cols, size_t rowStride, size_t colStride) :
+        m_data {data},
+        m_rows {rows},
+        m_cols {cols},
+        m_rowStride {rowStride},
+        m_colStride {colStride}
+    { }
+
+    // A view over mutable elements can always be seen as a read-only one.
+    template<typename U>
+    MatrixView(const MatrixView<U>& other) :
+        MatrixView {other.Data(), other.Rows(), other.Cols(), other.RowStride(), other.ColStride()}
+    { }
+
+    T& operator()(size_t i, size_t j) const
+    {
+        return m_data[i * m_rowStride + j * m_colStride];
+    }
+
+    MatrixView Row(size_t i) const
+    {
+        return Block(i, 0, 1, m_cols);
+    }
+
+    MatrixView Col(size_t j) const
+    {
+        return Block(0, j, m_rows, 1);
+    }
+
+    // Submatrix of rows x cols elements whose top-left corner is (i, j).
+    MatrixView Block(size_t i, size_t j, size_t rows, size_t cols) const
+    {
+        if (i + rows > m_rows || j + cols > m_cols)
+            throw std::out_of_range {"MatrixView::Block: block exceeds view bounds"};
+
+        // An empty block has no corner element: (i, j) may lie outside the
+        // storage, or there may be no storage at all.
+        if (rows == 0 || cols == 0)
+            return {m_data, rows, cols, m_rowStride, m_colStride};
+
+        return {&(*this)(i, j), rows, cols, m_rowStride, m_colStride};
+    }
+
+    // Transposing a view only swaps its dimensions and strides.
+    MatrixView Transpose() const
+    {
+        return {m_data, m_cols, m_rows, m_colStride, m_rowStride};
+    }
+
+    iterator begin() const
+    {
+        if (m_rows == 0 || m_cols == 0)
+            return end();
+
+        return {m_data, 0, m_cols, m_rowStride, m_colStride};
+    }
+
+    iterator end() const
+    {
+        return {m_data, m_rows, m_cols, m_rowStride, m_colStride};
+    }
+
+    T* Data() const { return m_data; }
+    size_t Rows() const { return m_rows; }
+    size_t Cols() const { return m_cols; }
+    size_t RowStride() const { return m_rowStride; }
+    size_t ColStride() const { return m_colStride; }
+
+private:
+    T* m_data;
+    size_t m_rows;
+    size_t m_cols;
+    size_t m_rowStride;
+    size_t m_colStride;
+};
+
+// Cache-oblivious out-of-place transpose: dst = src^T.
+// The larger side is halved recursively until blocks are small enough to fit
+// in any cache level, so both the reads from src and the writes to dst stay
+// local even when one of them walks a column.
+template<typename T>
+void Transpose(MatrixView<const T> src, MatrixView<T> dst)
+{
+    if (src.Rows() != dst.Cols() || src.Cols() != dst.Rows())
+        throw std::invalid_argument {"Transpose: destination has wrong dimensions"};
+
+    const size_t rows = src.Rows();
+    const size_t cols = src.Cols();
+
+    if (rows == 0 || cols == 0)
+        return;
+
+    if (rows <= TRANSPOSE_LEAF && cols <= TRANSPOSE_LEAF)
+    {
+        for (size_t i = 0; i < rows; ++i)
+            for (size_t j = 0; j < cols; ++j)
+                dst(j, i) = src(i, j);
+    }
+    else if (rows >= cols)
+    {
+        const size_t h = rows / 2;
+        Transpose(src.Block(0, 0, h, cols), dst.Block(0, 0, cols, h));
+        Transpose(src.Block(h, 0, rows - h, cols), dst.Block(0, h, cols, rows - h));
+    }
+    else
+    {
+        const size_t w = cols / 2;
+        Transpose(src.Block(0, 0, rows, w), dst.Block(0, 0, w, rows));
+        Transpose(src.Block(0, w, rows, cols - w), dst.Block(w, 0, cols - w, rows));
+    }
+}
+
+// Template deduction does not see the conversion from a mutable view to a
+// read-only one: forward mutable sources explicitly.
+template<typename T>
+void Transpose(MatrixView<T> src, MatrixView<T> dst)
+{
+    Transpose(MatrixView<const T> {src}, dst);
+}
+
+// Swap a with b^T, where a and b are disjoint blocks of the same matrix.
+// This is the off-diagonal step of the in-place square transpose.
+template<typename T>
+void TransposeSwap(MatrixView<T> a, MatrixView<T> b)
+{
+    const size_t rows = a.Rows();
+    const size_t cols = a.Cols();
+
+    if (rows <= TRANSPOSE_LEAF && cols <= TRANSPOSE_LEAF)
+    {
+        for (size_t i = 0; i < rows; ++i)
+            for (size_t j = 0; j < cols; ++j)
+                std::swap(a(i, j), b(j, i));
+    }
+    else if (rows >= cols)
+    {
+        const size_t h = rows / 2;
+        TransposeSwap(a.Block(0, 0, h, cols), b.Block(0, 0, cols, h));
+        TransposeSwap(a.Block(h, 0, rows - h, cols), b.Block(0, h, cols, rows - h));
+    }
+    else
+    {
+        const size_t w = cols / 2;
+        TransposeSwap(a.Block(0, 0, rows, w), b.Block(0, 0, w, rows));
+        TransposeSwap(a.Block(0, w, rows, cols - w), b.Block(w, 0, cols - w, rows));
+    }
+}
+
+// Cache-oblivious in-place transpose of a square view: transpose the two
+// diagonal blocks recursively and swap the two off-diagonal ones.
+template<typename T>
+void TransposeInPlace(MatrixView<T> m)
+{
+    if (m.Rows() != m.Cols())
+        throw std::invalid_argument {"TransposeInPlace: view is not square"};
+
+    const size_t n = m.Rows();
+
+    if (n <= TRANSPOSE_LEAF)
+    {
+        for (size_t i = 0; i < n; ++i)
+            for (size_t j = i + 1; j < n; ++j)
+                std::swap(m(i, j), m(j, i));
+        return;
+    }
+
+    const size_t h = n / 2;
+    TransposeInPlace(m.Block(0, 0, h, h));
+    TransposeInPlace(m.Block(h, h, n - h, n - h));
+    TransposeSwap(m.Block(0, h, h, n - h), m.Block(h, 0, n - h, h));
+}
+
 template<typename T>
 class Matrix
 {
 public:
     typedef typename std::vector<T>::iterator iterator;
+    typedef typename std::vector<T>::const_iterator const_iterator;
+
+    Matrix(size_t rows, size_t cols, const T& value = T {}) :
+        m_x {rows},
+        m_y {cols},
+        m_storage(rows * cols, value)
+    { }
 
+    // Adopt an existing row-major buffer of rows * cols elements: the
+    // elements themselves are neither copied nor moved.
+    Matrix(size_t rows, size_t cols, std::vector<T>&& storage) :
+        m_x {rows},
+        m_y {cols},
+        m_storage {std::move(storage)}
+    {
+        CheckSize();
+    }
+
+    // Copy rows * cols elements, in row-major order, from [first, last) with
+    // a single bulk copy.
+    template<typename InputIt>
+    Matrix(size_t rows, size_t cols, InputIt first, InputIt last) :
+        m_x {rows},
+        m_y {cols},
+        m_storage(first, last)
+    {
+        CheckSize();
+    }
+
+    // initializer_list elements are const, so they can only be copied: do it
+    // one whole row at a time rather than element by element.
     Matrix(std::initializer_list<std::initializer_list<T>> init) :
         m_x {init.size()},
-        m_y {init.begin()->size()}
+        m_y {init.size() == 0 ? 0 : init.begin()->size()}
     {
         m_storage.reserve(m_x * m_y);
 
         for (const auto& r : init)
-            for (const auto& v : r)
-                m_storage.emplace_back(v);
+        {
+            if (r.size() != m_y)
+                throw std::invalid_argument {"Matrix: all rows must have the same length"};
+
+            m_storage.insert(m_storage.end(), r.begin(), r.end());
+        }
+    }
+
+    Matrix(const Matrix& other) = default;
+    Matrix& operator=(const Matrix& other) = default;
+
+    // Moving only steals the storage buffer. Being noexcept, it is also what
+    // std::vector<Matrix<T>> picks when it grows, and what a function
+    // returning a Matrix by value falls back to when copy elision is disabled
+    // (-fno-elide-constructors).
+    Matrix(Matrix&& other) noexcept :
+        m_x {other.m_x},
+        m_y {other.m_y},
+        m_storage {std::move(other.m_storage)}
+    {
+        other.m_x = 0;
+        other.m_y = 0;
+    }
+
+    Matrix& operator=(Matrix&& other) noexcept
+    {
+        if (this == &other)
+            return *this;
+
+        m_x = other.m_x;
+        m_y = other.m_y;
+        m_storage = std::move(other.m_storage);
+
+        other.m_x = 0;
+        other.m_y = 0;
+        other.m_storage.clear();
+
+        return *this;
+    }
+
+    T& operator()(size_t i, size_t j)
+    {
+        return m_storage[i * m_y + j];
+    }
+
+    const T& operator()(size_t i, size_t j) const
+    {
+        return m_storage[i * m_y + j];
+    }
+
+    size_t Rows() const
+    {
+        return m_x;
+    }
+
+    size_t Cols() const
+    {
+        return m_y;
+    }
+
+    size_t Size() const
+    {
+        return m_storage.size();
+    }
+
+    // Views over the whole matrix, or part of it, sharing its storage.
+    // They are invalidated by anything that reallocates the storage.
+    MatrixView<T> View()
+    {
+        return {m_storage.data(), m_x, m_y, m_y, 1};
+    }
+
+    MatrixView<const T> View() const
+    {
+        return {m_storage.data(), m_x, m_y, m_y, 1};
+    }
+
+    MatrixView<T> Row(size_t i) { return View().Row(i); }
+    MatrixView<const T> Row(size_t i) const { return View().Row(i); }
+
+    MatrixView<T> Col(size_t j) { return View().Col(j); }
+    MatrixView<const T> Col(size_t j) const { return View().Col(j); }
+
+    MatrixView<T> Block(size_t i, size_t j, size_t rows, size_t cols)
+    {
+        return View().Block(i, j, rows, cols);
+    }
+
+    MatrixView<const T> Block(size_t i, size_t j, size_t rows, size_t cols) const
+    {
+        return View().Block(i, j, rows, cols);
+    }
+
+    // Transposed view: no element is moved.
+    MatrixView<T> TransposeView() { return View().Transpose(); }
+    MatrixView<const T> TransposeView() const { return View().Transpose(); }
+
+    // Transposed copy, laid out row-major.
+    Matrix Transposed() const
+    {
+        Matrix t(m_y, m_x);
+        ::Transpose(View(), t.View());
+        return t;
+    }
+
+    // Transpose the storage itself. Square matrices are transposed in place;
+    // rectangular ones go through a single scratch buffer.
+    void Transpose()
+    {
+        if (m_x == m_y)
+            TransposeInPlace(View());
+        else
+            *this = Transposed();
     }
 
     iterator begin()
@@ -28,14 +437,646 @@ public:
     {
         return m_storage.end();
     }
-    
+
+    const_iterator begin() const
+    {
+        return m_storage.begin();
+    }
+
+    const_iterator end() const
+    {
+        return m_storage.end();
+    }
+
 private:
+    void CheckSize() const
+    {
+        if (m_storage.size() != m_x * m_y)
+            throw std::invalid_argument {"Matrix: element count does not match dimensions"};
+    }
+
     size_t m_x;
     size_t m_y;
 
     std::vector<T> m_storage;
 };
 
+// ===========================================================================
+// Reductions
+// ===========================================================================
+
+// Minimum number of elements worth handing to a worker thread: below it,
+// waking threads up costs more than summing the elements serially.
+constexpr static size_t REDUCE_GRAIN = 1 << 16;
+
+// Below this many elements, pairwise summation stops splitting.
+constexpr static size_t PAIRWISE_LEAF = 128;
+
+// Fixed set of worker threads running fork-join jobs: Run() hands the same
+// task to every worker and returns once all of them have finished it.
+// Threads are created once and reused, so a reduction never pays for thread
+// creation.
+class ThreadPool
+{
+public:
+    explicit ThreadPool(size_t n) :
+        m_task {nullptr},
+        m_generation {},
+        m_pending {},
+        m_stop {false}
+    {
+        for (size_t i = 0; i < n; ++i)
+            m_threads.emplace_back(&ThreadPool::Work, this, i);
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock {m_mutex};
+            m_stop = true;
+        }
+        m_start.notify_all();
+
+        for (auto& t : m_threads)
+            t.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t Size() const
+    {
+        return m_threads.size();
+    }
+
+    // Call task(i) on worker i, for every worker, and wait for all of them.
+    // The first exception thrown by a task is rethrown here.
+    // Jobs submitted from several threads at once run one after the other.
+    void Run(const std::function<void(size_t)>& task)
+    {
+        std::lock_guard<std::mutex> job {m_runMutex};
+        std::unique_lock<std::mutex> lock {m_mutex};
+        m_task = &task;
+        m_error = nullptr;
+        m_pending = m_threads.size();
+        ++m_generation;
+        m_start.notify_all();
+
+        m_done.wait(lock, [this] { return m_pending == 0; });
+        m_task = nullptr;
+
+        if (m_error)
+            std::rethrow_exception(m_error);
+    }
+
+private:
+    void Work(size_t idx)
+    {
+        size_t seen {};
+
+        for (;;)
+        {
+            const std::function<void(size_t)>* task;
+            {
+                std::unique_lock<std::mutex> lock {m_mutex};
+                m_start.wait(lock, [&] { return m_stop || m_generation != seen; });
+                if (m_stop)
+                    return;
+                seen = m_generation;
+                task = m_task;
+            }
+
+            // make sure no exception leaves the thread, hand it over to Run()
+            std::exception_ptr error;
+            try
+            {
+                (*task)(idx);
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+
+            std::lock_guard<std::mutex> lock {m_mutex};
+            if (error && !m_error)
+                m_error = error;
+            if (--m_pending == 0)
+                m_done.notify_one();
+        }
+    }
+
+    std::vector<std::thread> m_threads;
+    std::mutex m_runMutex; // held by Run() for a whole job
+    std::mutex m_mutex;    // guards the state below
+    std::condition_variable m_start;
+    std::condition_variable m_done;
+    const std::function<void(size_t)>* m_task;
+    std::exception_ptr m_error;
+    size_t m_generation;
+    size_t m_pending;
+    bool m_stop;
+};
+
+// Pool shared by all reductions, one worker per hardware thread.
+inline ThreadPool& ReductionPool()
+{
+    static ThreadPool pool {std::max<size_t>(1, std::thread::hardware_concurrency())};
+    return pool;
+}
+
+// Split [0, n) into contiguous ranges of at least grain items, at most one per
+// worker, and call body(begin, end, part) on each of them in parallel.
+// Returns the number of parts used.
+template<typename Body>
+size_t ParallelFor(size_t n, size_t grain, Body body)
+{
+    ThreadPool& pool = ReductionPool();
+    const size_t parts = std::max<size_t>(1, std::min(pool.Size(), n / std::max<size_t>(1, grain)));
+
+    if (parts == 1)
+    {
+        body(0, n, 0);
+        return 1;
+    }
+
+    pool.Run([&] (size_t part) {
+        if (part < parts)
+            body(n * part / parts, n * (part + 1) / parts, part);
+    });
+
+    return parts;
+}
+
+// Run chunk(begin, end) over parallel ranges of [0, n) and collect the
+// per-thread partial results, in range order.
+template<typename R, typename Chunk>
+std::vector<R> ParallelPartials(size_t n, size_t grain, Chunk chunk)
+{
+    ThreadPool& pool = ReductionPool();
+    std::vector<R> partials(pool.Size());
+
+    const size_t parts = ParallelFor(n, grain, [&] (size_t b, size_t e, size_t part) {
+        partials[part] = chunk(b, e);
+    });
+
+    partials.resize(parts);
+    return partials;
+}
+
+enum class Summation
+{
+    Naive,    // fastest, error grows linearly with the number of elements
+    Kahan,    // compensated, error independent of the number of elements
+    Pairwise  // recursive halving, error grows with log(n), almost as fast as Naive
+};
+
+// The kernels below walk n elements, stride apart, starting at p. They keep
+// four independent accumulators ("lanes"), so that consecutive additions do
+// not wait on each other and an optimizing compiler can map the lanes onto
+// SIMD registers. Sums accumulate in A, by default the element type itself.
+template<typename T, typename A = T>
+A SumNaive(const T* p, size_t n, size_t stride = 1)
+{
+    A a0 {}, a1 {}, a2 {}, a3 {};
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4)
+    {
+        a0 += p[i * stride];
+        a1 += p[(i + 1) * stride];
+        a2 += p[(i + 2) * stride];
+        a3 += p[(i + 3) * stride];
+    }
+    for (; i < n; ++i)
+        a0 += p[i * stride];
+
+    return (a0 + a1) + (a2 + a3);
+}
+
+// One step of compensated summation: c carries the low-order bits lost so far.
+template<typename T>
+void KahanAdd(T& sum, T& c, const T& x)
+{
+    const T y = x - c;
+    const T t = sum + y;
+    c = (t - sum) - y;
+    sum = t;
+}
+
+template<typename T, typename A = T>
+A SumKahan(const T* p, size_t n, size_t stride = 1)
+{
+    A sum {};
+    A c {};
+
+    for (size_t i = 0; i < n; ++i)
+        KahanAdd(sum, c, static_cast<A>(p[i * stride]));
+
+    return sum;
+}
+
+template<typename T, typename A = T>
+A SumPairwise(const T* p, size_t n, size_t stride = 1)
+{
+    if (n <= PAIRWISE_LEAF)
+        return SumNaive<T, A>(p, n, stride);
+
+    const size_t h = n / 2;
+    return SumPairwise<T, A>(p, h, stride) + SumPairwise<T, A>(p + h * stride, n - h, stride);
+}
+
+template<typename T, typename A = T>
+A SumRange(const T* p, size_t n, Summation s, size_t stride = 1)
+{
+    switch (s)
+    {
+    case Summation::Kahan:
+        return SumKahan<T, A>(p, n, stride);
+    case Summation::Pairwise:
+        return SumPairwise<T, A>(p, n, stride);
+    default:
+        return SumNaive<T, A>(p, n, stride);
+    }
+}
+
+// Sum of the squares of n elements, stride apart, accumulated in double.
+template<typename T>
+double SumSquares(const T* p, size_t n, size_t stride = 1)
+{
+    double a[4] {};
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4)
+        for (size_t l = 0; l < 4; ++l)
+            a[l] += static_cast<double>(p[(i + l) * stride]) * p[(i + l) * stride];
+    for (; i < n; ++i)
+        a[0] += static_cast<double>(p[i * stride]) * p[i * stride];
+
+    return (a[0] + a[1]) + (a[2] + a[3]);
+}
+
+// Smallest and largest of n >= 1 elements, stride apart.
+template<typename T>
+std::pair<T, T> MinMaxRange(const T* p, size_t n, size_t stride = 1)
+{
+    T lo[4] {p[0], p[0], p[0], p[0]};
+    T hi[4] {p[0], p[0], p[0], p[0]};
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4)
+        for (size_t l = 0; l < 4; ++l)
+        {
+            lo[l] = std::min(lo[l], p[(i + l) * stride]);
+            hi[l] = std::max(hi[l], p[(i + l) * stride]);
+        }
+    for (; i < n; ++i)
+    {
+        lo[0] = std::min(lo[0], p[i * stride]);
+        hi[0] = std::max(hi[0], p[i * stride]);
+    }
+
+    return std::make_pair(*std::min_element(lo, lo + 4), *std::max_element(hi, hi + 4));
+}
+
+// Reorient a view for reductions that ignore element order: rows become as
+// long and as contiguous as possible, and a contiguous view a single row.
+template<typename T>
+MatrixView<const T> Linearize(MatrixView<const T> v)
+{
+    if ((v.ColStride() != 1 && v.RowStride() == 1) || (v.Cols() == 1 && v.Rows() > 1))
+        v = v.Transpose();
+
+    if (v.ColStride() == 1 && v.RowStride() == v.Cols())
+        return {v.Data(), 1, v.Rows() * v.Cols(), v.Rows() * v.Cols(), 1};
+
+    return v;
+}
+
+// Call f(p, n, stride) on the row segments covering elements [b, e) of v,
+// counted in row-major order.
+template<typename T, typename F>
+void ForEachSegment(const MatrixView<const T>& v, size_t b, size_t e, F f)
+{
+    const size_t cols = v.Cols();
+
+    while (b < e)
+    {
+        const size_t j = b % cols;
+        const size_t n = std::min(cols - j, e - b);
+        f(&v(b / cols, j), n, v.ColStride());
+        b += n;
+    }
+}
+
+// Sum of all the elements of a view, accumulated in A.
+template<typename A, typename T>
+A SumAs(MatrixView<T> view, Summation s)
+{
+    typedef typename std::remove_const<T>::type V;
+    const MatrixView<const V> v = Linearize(MatrixView<const V> {view});
+
+    const auto partials = ParallelPartials<A>(v.Rows() * v.Cols(), REDUCE_GRAIN, [&] (size_t b, size_t e) {
+        A sum {};
+        A c {};
+        ForEachSegment(v, b, e, [&] (const V* p, size_t n, size_t stride) {
+            if (s == Summation::Naive)
+                sum += SumRange<V, A>(p, n, s, stride);
+            else
+                KahanAdd(sum, c, SumRange<V, A>(p, n, s, stride));
+        });
+        return sum;
+    });
+
+    // Few partials are left: compensate them unless plain speed was asked.
+    return SumRange(partials.data(), partials.size(), s == Summation::Naive ? s : Summation::Kahan);
+}
+
+// Reductions accept any view, rows, blocks and transposes included, as well
+// as whole matrices.
+template<typename T>
+typename std::remove_const<T>::type Sum(MatrixView<T> view, Summation s = Summation::Pairwise)
+{
+    return SumAs<typename std::remove_const<T>::type>(view, s);
+}
+
+template<typename T>
+T Sum(const Matrix<T>& m, Summation s = Summation::Pairwise)
+{
+    return Sum(m.View(), s);
+}
+
+// Elements are added up in double, so integer matrices cannot overflow.
+template<typename T>
+double Mean(MatrixView<T> view, Summation s = Summation::Pairwise)
+{
+    const size_t size = view.Rows() * view.Cols();
+
+    if (size == 0)
+        throw std::invalid_argument {"Mean: empty view"};
+
+    return SumAs<double>(view, s) / size;
+}
+
+template<typename T>
+double Mean(const Matrix<T>& m, Summation s = Summation::Pairwise)
+{
+    return Mean(m.View(), s);
+}
+
+// Smallest and largest elements, in this order.
+template<typename T>
+std::pair<typename std::remove_const<T>::type, typename std::remove_const<T>::type>
+MinMax(MatrixView<T> view)
+{
+    typedef typename std::remove_const<T>::type V;
+    const MatrixView<const V> v = Linearize(MatrixView<const V> {view});
+    const size_t size = v.Rows() * v.Cols();
+
+    if (size == 0)
+        throw std::invalid_argument {"MinMax: empty view"};
+
+    const auto partials = ParallelPartials<std::pair<V, V>>(size, REDUCE_GRAIN, [&] (size_t b, size_t e) {
+        std::pair<V, V> r {v(b / v.Cols(), b % v.Cols()), v(b / v.Cols(), b % v.Cols())};
+        ForEachSegment(v, b, e, [&] (const V* p, size_t n, size_t stride) {
+            const std::pair<V, V> seg {MinMaxRange(p, n, stride)};
+            r.first = std::min(r.first, seg.first);
+            r.second = std::max(r.second, seg.second);
+        });
+        return r;
+    });
+
+    std::pair<V, V> r {partials.front()};
+    for (const auto& part : partials)
+    {
+        r.first = std::min(r.first, part.first);
+        r.second = std::max(r.second, part.second);
+    }
+
+    return r;
+}
+
+template<typename T>
+std::pair<T, T> MinMax(const Matrix<T>& m)
+{
+    return MinMax(m.View());
+}
+
+// Frobenius norm: square root of the sum of all squared elements.
+template<typename T>
+double Norm(MatrixView<T> view)
+{
+    typedef typename std::remove_const<T>::type V;
+    const MatrixView<const V> v = Linearize(MatrixView<const V> {view});
+
+    const auto partials = ParallelPartials<double>(v.Rows() * v.Cols(), REDUCE_GRAIN, [&] (size_t b, size_t e) {
+        double sum {};
+        ForEachSegment(v, b, e, [&] (const V* p, size_t n, size_t stride) {
+            sum += SumSquares(p, n, stride);
+        });
+        return sum;
+    });
+
+    return std::sqrt(SumKahan(partials.data(), partials.size()));
+}
+
+template<typename T>
+double Norm(const Matrix<T>& m)
+{
+    return Norm(m.View());
+}
+
+// Count of elements falling in each of bins equal-width intervals that
+// split [lo, hi). Elements outside [lo, hi) are not counted.
+template<typename T>
+std::vector<size_t> Histogram(MatrixView<T> view, size_t bins,
+                              typename std::remove_const<T>::type lo, typename std::remove_const<T>::type hi)
+{
+    typedef typename std::remove_const<T>::type V;
+
+    if (bins == 0 || !(lo < hi))
+        throw std::invalid_argument {"Histogram: need at least one bin and lo < hi"};
+
+    const MatrixView<const V> v = Linearize(MatrixView<const V> {view});
+    const double scale = bins / (static_cast<double>(hi) - lo);
+
+    // Each thread fills its own private histogram, merged at the end.
+    const auto partials = ParallelPartials<std::vector<size_t>>(v.Rows() * v.Cols(), REDUCE_GRAIN,
+                                                              [&] (size_t b, size_t e) {
+        std::vector<size_t> h(bins);
+
+        ForEachSegment(v, b, e, [&] (const V* p, size_t n, size_t stride) {
+            for (size_t i = 0; i < n; ++i)
+            {
+                const V x = p[i * stride];
+                if (!(x < lo) && x < hi)
+                    ++h[std::min(bins - 1, static_cast<size_t>((x - lo) * scale))];
+            }
+        });
+
+        return h;
+    });
+
+    std::vector<size_t> r(bins);
+    for (const auto& part : partials)
+        for (size_t k = 0; k < bins; ++k)
+            r[k] += part[k];
+
+    return r;
+}
+
+template<typename T>
+std::vector<size_t> Histogram(const Matrix<T>& m, size_t bins, T lo, T hi)
+{
+    return Histogram(m.View(), bins, lo, hi);
+}
+
+template<typename T>
+std::vector<typename std::remove_const<T>::type> ColSums(MatrixView<T> view, Summation s = Summation::Pairwise);
+
+// One sum per row, each summed like a vector along the row.
+template<typename T>
+std::vector<typename std::remove_const<T>::type> RowSums(MatrixView<T> view, Summation s = Summation::Pairwise)
+{
+    typedef typename std::remove_const<T>::type V;
+    const MatrixView<const V> v {view};
+
+    // Columns are contiguous instead: streaming through memory means summing
+    // the columns of the transpose.
+    if (v.ColStride() != 1 && v.RowStride() == 1)
+        return ColSums(v.Transpose(), s);
+
+    std::vector<V> r(v.Rows());
+    if (v.Cols() == 0)
+        return r;
+
+    ParallelFor(v.Rows(), REDUCE_GRAIN / v.Cols(), [&] (size_t b, size_t e, size_t) {
+        for (size_t i = b; i < e; ++i)
+            r[i] = SumRange(&v(i, 0), v.Cols(), s, v.ColStride());
+    });
+
+    return r;
+}
+
+template<typename T>
+std::vector<T> RowSums(const Matrix<T>& m, Summation s = Summation::Pairwise)
+{
+    return RowSums(m.View(), s);
+}
+
+// Scratch elements ColSumsRange() needs for rows rows of cols columns: one
+// row of partial totals per pairwise recursion level, or the per-column
+// compensations for Kahan summation.
+inline size_t ColSumsScratch(size_t rows, size_t cols, Summation s)
+{
+    if (s == Summation::Kahan)
+        return cols;
+
+    size_t depth {};
+    if (s == Summation::Pairwise)
+        for (; rows > PAIRWISE_LEAF; rows -= rows / 2)
+            ++depth;
+
+    return depth * cols;
+}
+
+// Write to out the column totals of rows [b, e) of v. Whole rows are
+// streamed one after the other rather than walking down each column.
+// scratch must hold ColSumsScratch(e - b, v.Cols(), s) elements, so that the
+// recursion never allocates.
+template<typename T>
+void ColSumsRange(const MatrixView<const T>& v, size_t b, size_t e, Summation s, T* out, T* scratch)
+{
+    const T* p = v.Data();
+    const size_t cols = v.Cols();
+    const size_t rs = v.RowStride();
+    const size_t cs = v.ColStride();
+
+    if (s == Summation::Pairwise && e - b > PAIRWISE_LEAF)
+    {
+        const size_t h = b + (e - b) / 2;
+        T* lower = scratch;
+        ColSumsRange(v, b, h, s, out, scratch + cols);
+        ColSumsRange(v, h, e, s, lower, scratch + cols);
+
+        for (size_t j = 0; j < cols; ++j)
+            out[j] += lower[j];
+        return;
+    }
+
+    std::fill(out, out + cols, T {});
+
+    if (s == Summation::Kahan)
+    {
+        T* c = scratch;
+        std::fill(c, c + cols, T {});
+
+        for (size_t i = b; i < e; ++i)
+            for (size_t j = 0; j < cols; ++j)
+                KahanAdd(out[j], c[j], p[i * rs + j * cs]);
+        return;
+    }
+
+    for (size_t i = b; i < e; ++i)
+        for (size_t j = 0; j < cols; ++j)
+            out[j] += p[i * rs + j * cs];
+}
+
+// One sum per column. Each thread sums a band of rows into its own vector of
+// column totals, then the bands are added together.
+template<typename T>
+std::vector<typename std::remove_const<T>::type> ColSums(MatrixView<T> view, Summation s)
+{
+    typedef typename std::remove_const<T>::type V;
+    const MatrixView<const V> v {view};
+
+    // Columns are contiguous instead: sum the rows of the transpose.
+    if (v.ColStride() != 1 && v.RowStride() == 1)
+        return RowSums(v.Transpose(), s);
+
+    const size_t cols = v.Cols();
+
+    const auto partials = ParallelPartials<std::vector<V>>(v.Rows(), REDUCE_GRAIN / std::max<size_t>(1, cols),
+                                                         [&] (size_t b, size_t e) {
+        std::vector<V> acc(cols);
+        std::vector<V> scratch(ColSumsScratch(e - b, cols, s));
+        ColSumsRange(v, b, e, s, acc.data(), scratch.data());
+        return acc;
+    });
+
+    std::vector<V> r(cols);
+    for (const auto& part : partials)
+        for (size_t j = 0; j < cols; ++j)
+            r[j] += part[j];
+
+    return r;
+}
+
+template<typename T>
+std::vector<T> ColSums(const Matrix<T>& m, Summation s = Summation::Pairwise)
+{
+    return ColSums(m.View(), s);
+}
+
+// Returning by value moves the local matrix out: its buffer is never copied.
+template<typename T>
+Matrix<T> Identity(size_t n)
+{
+    Matrix<T> id(n, n);
+    for (size_t i = 0; i < n; ++i)
+        id(i, i) = T {1};
+    return id;
+}
+
+// Any container of elements, Matrix or MatrixView alike, can be printed.
+template<typename C>
+void Print(const std::string& name, const C& c)
+{
+    std::cout << name << ": ";
+    for (const auto& v : c)
+        std::cout << v << " ";
+    std::cout << std::endl;
+}
+
 int main()
 {
     Matrix<int> m {{1,2,3}, {4,5,6}, {7,8,9}};
@@ -43,4 +1084,75 @@ int main()
     for (const auto& v : m)
         std::cout << v << " ";
     std::cout << std::endl;
+
+    // Views share the storage of m: writing through them modifies m.
+    m.Col(1)(2, 0) = 80;
+    Print("row 2", m.Row(2));
+    Print("col 1", m.Col(1));
+    Print("block", m.Block(1, 1, 2, 2));
+    Print("transposed view", m.TransposeView());
+    std::cout << "sum of col 2: "
+              << std::accumulate(m.Col(2).begin(), m.Col(2).end(), 0) << std::endl;
+
+    Matrix<int> r {{1,2,3}, {4,5,6}};
+    Print("transposed copy", r.Transposed());
+
+    Matrix<int> rt(3, 2);
+    Transpose(r.View(), rt.View());
+    Print("transposed into", rt);
+    r.Transpose();
+    Print("in-place transposed", r);
+
+    std::vector<int> buf {1, 2, 3, 4, 5, 6};
+    const int* data = buf.data();
+    Matrix<int> adopted(3, 2, std::move(buf));
+    std::cout << "buffer adopted without copies: " << std::boolalpha
+              << (adopted.View().Data() == data) << std::endl;
+
+    Matrix<int> ranged(2, 3, adopted.begin(), adopted.end());
+    Print("from iterator range", ranged);
+    Print("identity", Identity<int>(3));
+
+    try
+    {
+        Matrix<int> ragged {{1, 2}, {3}};
+    }
+    catch (const std::invalid_argument& e)
+    {
+        std::cout << "ERROR: " << e.what() << std::endl;
+    }
+
+    // Adding 0.1f sixteen million times shows how much each summation drifts
+    // from the exact result, 1677721.6.
+    Matrix<float> big(4096, 4096, 0.1f);
+    std::cout << "naive sum: " << Sum(big, Summation::Naive) << std::endl;
+    std::cout << "kahan sum: " << Sum(big, Summation::Kahan) << std::endl;
+    std::cout << "pairwise sum: " << Sum(big, Summation::Pairwise) << std::endl;
+
+    Matrix<double> d {{1.5, -2.0, 3.0}, {4.0, 0.5, -6.0}};
+    const auto mm = MinMax(d);
+    std::cout << "min: " << mm.first << " max: " << mm.second
+              << " mean: " << Mean(d) << " norm: " << Norm(d) << std::endl;
+    Print("histogram [-6, 6) in 4 bins", Histogram(d, 4, -6.0, 6.0));
+    Print("row sums", RowSums(d));
+    Print("col sums", ColSums(d));
+
+    // Views are reduced in place, without copying them first.
+    const auto cm = MinMax(d.Col(2));
+    std::cout << "sum of row 1: " << Sum(d.Row(1)) << ", col 2 min: " << cm.first
+              << " max: " << cm.second << ", mean: " << Mean(d.Col(2))
+              << ", norm: " << Norm(d.Block(0, 1, 2, 2)) << std::endl;
+    Print("row sums of transpose", RowSums(d.TransposeView()));
+    Print("col sums of block", ColSums(d.Block(0, 1, 2, 2)));
+    Print("histogram of row 0", Histogram(d.Row(0), 2, -6.0, 6.0));
+    std::cout << "mean of 9M ints: " << Mean(Matrix<int>(3000, 3000, 1000)) << std::endl;
+
+    // Several threads may reduce at once: the shared pool runs their jobs one
+    // after the other.
+    float sums[2] {};
+    std::thread first {[&] { sums[0] = Sum(big); }};
+    std::thread second {[&] { sums[1] = Sum(big.TransposeView()); }};
+    first.join();
+    second.join();
+    std::cout << "concurrent sums: " << sums[0] << " " << sums[1] << std::endl;
 }